@@ -0,0 +1,130 @@
+#include "modules/chess/chess_module.hpp"
+#include "modules/chess/move_batch.hpp"
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> sorted_uci(std::vector<Move>::const_iterator begin, std::vector<Move>::const_iterator end) {
+    std::vector<std::string> uci;
+    for (auto it = begin; it != end; ++it) {
+        uci.push_back(it->to_uci());
+    }
+    std::sort(uci.begin(), uci.end());
+    return uci;
+}
+
+// Candidate moves for validation: every pawn (of either colour) moving by each pawn
+// offset in both directions, plus a move from an empty square and one off the board.
+// Most are illegal, which exercises the rejection paths as well as acceptance.
+std::vector<Move> validation_candidates(const ChessBoard& board) {
+    static const int offsets[] = { 8, 16, 7, 9, -8, -16, -7, -9 };
+    std::vector<Move> candidates;
+
+    for (int file = 0; file < 8; file++) {
+        for (int rank = 0; rank < 8; rank++) {
+            Position from(file, rank);
+            ChessPiece piece = board.get_piece(from);
+            if (piece.is_empty() && candidates.empty()) {
+                candidates.push_back(Move(from, Position(file, rank < 7 ? rank + 1 : rank - 1)));
+            }
+            if (piece.type != PieceType::PAWN) {
+                continue;
+            }
+            for (int offset : offsets) {
+                int to = rank * 8 + file + offset;
+                if (to >= 0 && to < 64) {
+                    candidates.push_back(Move(from, Position(to % 8, to / 8)));
+                }
+            }
+        }
+    }
+
+    candidates.push_back(Move(Position(4, 1), Position(4, 8)));
+    return candidates;
+}
+
+// Compare the batch generator and validator with ChessBoard on a sample of random games.
+// Returns false and reports the first mismatch.
+bool cross_check(unsigned seed) {
+    std::mt19937 rng(seed);
+    ChessBoard board;
+    std::vector<ChessBoard> boards;
+    PositionBatch sample;
+
+    while (boards.size() < 1000) {
+        auto legal_moves = board.get_legal_moves();
+        if (legal_moves.empty() || board.is_game_over()) {
+            board = ChessBoard();
+            continue;
+        }
+        boards.push_back(board);
+        sample.add(board);
+        std::uniform_int_distribution<size_t> pick(0, legal_moves.size() - 1);
+        board.make_move(legal_moves[pick(rng)]);
+    }
+
+    // Per-position move sets must match exactly
+    BatchMoves sample_moves = generate_moves_batch(sample);
+    for (size_t i = 0; i < boards.size(); i++) {
+        auto expected = boards[i].get_legal_moves();
+        auto begin = sample_moves.moves.cbegin();
+        if (sorted_uci(begin + sample_moves.offsets[i], begin + sample_moves.offsets[i + 1]) !=
+            sorted_uci(expected.cbegin(), expected.cend())) {
+            std::cerr << "ERROR: batch move set differs from get_legal_moves() at sample position " << i << std::endl;
+            return false;
+        }
+    }
+
+    // Validation must accept exactly the legal candidates and reject the rest
+    PositionBatch checks;
+    std::vector<Move> candidates;
+    std::vector<uint8_t> expected;
+    for (const ChessBoard& position : boards) {
+        auto legal_moves = position.get_legal_moves();
+        for (const Move& move : validation_candidates(position)) {
+            checks.add(position);
+            candidates.push_back(move);
+            expected.push_back(std::find(legal_moves.begin(), legal_moves.end(), move) != legal_moves.end());
+        }
+    }
+
+    std::vector<uint8_t> valid = validate_moves_batch(checks, candidates);
+    for (size_t i = 0; i < valid.size(); i++) {
+        if (valid[i] != expected[i]) {
+            std::cerr << "ERROR: batch validation " << (valid[i] ? "accepted illegal" : "rejected legal")
+                      << " move " << candidates[i].to_uci() << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "Cross-checked " << boards.size() << " positions and " << candidates.size()
+              << " candidate moves" << std::endl;
+    return true;
+}
+
+} // namespace
+
+// Measures batched move generation throughput on a corpus of random playout positions,
+// after checking the batch results against ChessBoard on a sample.
+int main(int argc, char** argv) {
+    size_t positions = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    int iterations = (argc > 2) ? std::atoi(argv[2]) : 10;
+
+    if (!cross_check(7)) {
+        return 1;
+    }
+
+    std::cout << "Building corpus of " << positions << " positions..." << std::endl;
+    PositionBatch corpus = build_benchmark_corpus(positions);
+
+    BatchStats stats = benchmark_moves_batch(corpus, iterations);
+    std::cout << "Generated " << stats.moves << " moves for " << stats.positions << " positions in "
+              << stats.seconds << " s" << std::endl;
+    std::cout << "Throughput: " << static_cast<uint64_t>(stats.positions_per_sec) << " positions/sec" << std::endl;
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "modules/shard_ipc.hpp"
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <csignal>
+#include <unistd.h>
+#include <sys/wait.h>
+
+// Runs the shard supervisor against fake worker processes and checks its side of the
+// IPC protocol: staggered startup, TOTALS aggregation, OWNER routing, restart of a
+// crashed worker, and clean shutdown. The workers do not run run_bot, so ShardModule,
+// the dpp::cluster shard/cluster-ID wiring and the chess module are not covered.
+
+namespace {
+
+// A fixed set of guilds with made-up game counts. Each fake worker reports the guilds
+// that worker_for_guild() assigns to it; nothing is routed by a real gateway.
+struct GuildFixture {
+    std::vector<uint64_t> guilds;
+
+    explicit GuildFixture(size_t count) {
+        std::mt19937_64 rng(42);
+        for (size_t i = 0; i < count; i++) {
+            guilds.push_back(rng() >> 1);
+        }
+    }
+
+    static uint64_t games_in(uint64_t guild_id) { return guild_id % 2; }
+    static uint64_t moves_in(uint64_t guild_id) { return guild_id % 40; }
+
+    // Metrics a worker would report for its share of the guilds (all of them for -1)
+    WorkerMetrics metrics_for(uint32_t worker_id, const ShardConfig& config) const {
+        WorkerMetrics metrics;
+        for (uint64_t guild_id : guilds) {
+            if (worker_id == static_cast<uint32_t>(-1) || worker_for_guild(guild_id, config) == worker_id) {
+                metrics.guilds++;
+                metrics.active_games += games_in(guild_id);
+                metrics.moves_played += moves_in(guild_id);
+            }
+        }
+        return metrics;
+    }
+};
+
+std::string crash_file(const ShardConfig& config, uint32_t worker_id) {
+    return config.ipc_path + ".crash" + std::to_string(worker_id);
+}
+
+// Fake worker: reports its share of the fixture until killed, or exits with status 3
+// when its crash file appears
+int fake_worker(uint32_t worker_id, const ShardConfig& config, const GuildFixture& fixture) {
+    ShardIpcClient ipc(config.ipc_path, worker_id);
+    WorkerMetrics metrics = fixture.metrics_for(worker_id, config);
+
+    while (true) {
+        ipc.send_metrics(metrics);
+        if (unlink(crash_file(config, worker_id).c_str()) == 0) {
+            return 3;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+template <typename Predicate>
+bool wait_for(Predicate predicate, std::chrono::seconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (predicate()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return false;
+}
+
+bool check(bool condition, const std::string& what) {
+    std::cout << (condition ? "PASS: " : "FAIL: ") << what << std::endl;
+    return condition;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ShardConfig config;
+    config.workers = 3;
+    config.shards = 6;
+    config.ipc_path = "/tmp/countdracula_harness_" + std::to_string(getpid()) + ".sock";
+    config.spawn_interval = std::chrono::milliseconds((argc > 1) ? std::atoi(argv[1]) : 300);
+
+    GuildFixture fixture(200);
+
+    auto started = std::chrono::steady_clock::now();
+    pid_t supervisor_pid = fork();
+    if (supervisor_pid < 0) {
+        std::cerr << "ERROR: Could not fork supervisor" << std::endl;
+        return 1;
+    }
+    if (supervisor_pid == 0) {
+        ShardSupervisor supervisor(config, [&](uint32_t worker_id) {
+            return fake_worker(worker_id, config, fixture);
+        });
+        std::_Exit(supervisor.run());
+    }
+
+    // The harness itself talks to the supervisor like one more worker would
+    ShardIpcClient ipc(config.ipc_path, config.workers);
+    WorkerMetrics expected = fixture.metrics_for(static_cast<uint32_t>(-1), config);
+    bool ok = true;
+
+    auto reporting_workers = [&]() {
+        WorkerMetrics totals;
+        uint32_t reporting = 0;
+        return ipc.query_totals(totals, reporting) ? reporting : 0;
+    };
+
+    // Startup: every worker reports, but not before the stagger allows
+    bool all_up = wait_for([&]() { return reporting_workers() == config.workers; }, std::chrono::seconds(20));
+    auto startup = std::chrono::steady_clock::now() - started;
+    ok &= check(all_up, "all workers report after startup");
+    ok &= check(startup >= config.spawn_interval * (config.workers - 1), "worker starts are staggered by the spawn interval");
+
+    // TOTALS sums every worker's report
+    WorkerMetrics totals;
+    uint32_t reporting = 0;
+    ok &= check(ipc.query_totals(totals, reporting) && totals.guilds == expected.guilds &&
+                totals.active_games == expected.active_games && totals.moves_played == expected.moves_played,
+                "TOTALS matches the guild fixture");
+
+    // OWNER routes every guild to the worker holding its shard
+    bool owners_ok = true;
+    for (uint64_t guild_id : fixture.guilds) {
+        uint32_t worker = 0, shard = 0;
+        bool alive = false;
+        owners_ok &= ipc.query_owner(guild_id, worker, shard, alive) && alive &&
+                     worker == worker_for_guild(guild_id, config) && shard == shard_for_guild(guild_id, config.shards);
+    }
+    ok &= check(owners_ok, "OWNER matches shard routing for every guild");
+
+    // Restart: crash worker 1, see it reported dead, then back with its metrics
+    uint64_t victim_guild = 0;
+    for (uint64_t guild_id : fixture.guilds) {
+        if (worker_for_guild(guild_id, config) == 1) {
+            victim_guild = guild_id;
+            break;
+        }
+    }
+    auto owner_alive = [&]() {
+        uint32_t worker = 0, shard = 0;
+        bool alive = false;
+        return ipc.query_owner(victim_guild, worker, shard, alive) && alive;
+    };
+    std::ofstream(crash_file(config, 1)).put('\n');
+    ok &= check(wait_for([&]() { return !owner_alive(); }, std::chrono::seconds(10)), "crashed worker is reported dead");
+    ok &= check(wait_for([&]() { return owner_alive() && reporting_workers() == config.workers; }, std::chrono::seconds(20)),
+                "crashed worker is restarted and reports again");
+    ok &= check(ipc.query_totals(totals, reporting) && totals.guilds == expected.guilds,
+                "TOTALS matches again after the restart");
+
+    // Shutdown: SIGTERM stops the workers and removes the socket
+    kill(supervisor_pid, SIGTERM);
+    int status = 0;
+    waitpid(supervisor_pid, &status, 0);
+    ok &= check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "supervisor exits cleanly on SIGTERM");
+    ok &= check(access(config.ipc_path.c_str(), F_OK) != 0, "IPC socket is removed");
+
+    return ok ? 0 : 1;
+}
@@ -1,47 +1,29 @@
 #include <dpp/dpp.h>
 #include "modules/greetings_module.hpp"
 #include "modules/chess/chess_module.hpp"
+#include "modules/trace.hpp"
+#include "modules/user_cache.hpp"
+#include "modules/shard_ipc.hpp"
+#include "modules/shard_module.hpp"
 #include <cstdlib>
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 
-int main() {
-    std::cout << "=== Count Dracula Bot Starting ===" << std::endl;
-    
-    // Get token and guild ID from environment variables
-    const char* token = std::getenv("DISCORD_BOT_TOKEN");
-    const char* guild_id_str = std::getenv("DISCORD_GUILD_ID");
-
-    if (!token) {
-        std::cerr << "ERROR: DISCORD_BOT_TOKEN environment variable was not set." << std::endl;
-        return 1;
-    }
-    
-    std::cout << "Token loaded successfully" << std::endl;
-    
-    // Parse guild ID if provided
-    dpp::snowflake guild_id = 0;
-    if (guild_id_str) {
-        try {
-            guild_id = std::stoull(guild_id_str);
-            std::cout << "Guild ID loaded from environment: " << guild_id << std::endl;
-        } catch (const std::exception& e) {
-            std::cerr << "WARNING: Could not parse DISCORD_GUILD_ID as a number: " << e.what() << std::endl;
-        }
-    } else {
-        std::cout << "WARNING: DISCORD_GUILD_ID environment variable not set. Guild-specific commands will not be registered." << std::endl;
-    }
-    
-    // Create a timestamp for our logs
-    auto now = std::chrono::system_clock::now();
-    auto time_t_now = std::chrono::system_clock::to_time_t(now);
-    std::cout << "Bot startup time: " << std::put_time(std::localtime(&time_t_now), "%Y-%m-%d %H:%M:%S") << std::endl;
-
-    // Create bot with specific intents, only requesting what we need
-    dpp::cluster bot(token, dpp::i_guilds | dpp::i_guild_messages | dpp::i_message_content);
+// Runs one bot process: the whole bot, or a single worker when ipc is set
+int run_bot(const char* token, dpp::snowflake guild_id, const ShardConfig& shard_config, ShardIpcClient* ipc) {
+    // Create bot with specific intents, only requesting what we need.
+    // A sharded worker connects only the shards D++ assigns to its cluster ID.
+    uint32_t intents = dpp::i_guilds | dpp::i_guild_messages | dpp::i_message_content;
+    uint32_t shards = ipc ? shard_config.shards : 0;
+    uint32_t cluster_id = ipc ? ipc->get_worker_id() : 0;
+    dpp::cluster bot(token, intents, shards, cluster_id, shard_config.workers);
     
     std::cout << "Bot cluster created with minimal required intents" << std::endl;
+    if (ipc) {
+        std::cout << "Worker " << cluster_id << " of " << shard_config.workers << " handling its share of "
+                  << shards << " shards" << std::endl;
+    }
 
     // Set up logging with extra error information
     bot.on_log([](const dpp::log_t& event) {
@@ -64,9 +46,42 @@ int main() {
         std::cout << "Guild member count: " << event.created.member_count << std::endl;
     });
 
+    // Hot-path tracing: COUNTDRACULA_TRACE=1 enables recording, SIGUSR1 dumps the
+    // last COUNTDRACULA_TRACE_SECONDS (default 10) as Chrome trace-event JSON
+    const char* trace_str = std::getenv("COUNTDRACULA_TRACE");
+    const char* trace_seconds_str = std::getenv("COUNTDRACULA_TRACE_SECONDS");
+    double trace_seconds = trace_seconds_str ? std::atof(trace_seconds_str) : 10.0;
+    if (trace_seconds <= 0) {
+        trace_seconds = 10.0;
+    }
+    Tracer::set_enabled(trace_str && std::string(trace_str) == "1");
+    Tracer::install_signal_handler();
+    bot.start_timer([trace_seconds](const dpp::timer&) {
+        if (Tracer::poll_dump_request()) {
+            try {
+                std::string path = Tracer::dump_to_file(trace_seconds);
+                std::cout << "Trace written to " << path << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << "ERROR: Could not dump trace: " << e.what() << std::endl;
+            }
+        }
+    }, 1);
+    std::cout << "Tracing " << (Tracer::is_enabled() ? "enabled" : "disabled") 
+              << " (send SIGUSR1 to dump the last " << trace_seconds << "s)" << std::endl;
+
     // Initialize modules
+    UserCache users(bot);
     GreetingsModule greetings(bot);
-    ChessModule chess(bot);
+    ChessModule chess(bot, users);
+    ShardModule shard(bot, ipc, [&chess]() {
+        ChessStats stats = chess.get_stats();
+        WorkerMetrics metrics;
+        metrics.guilds = dpp::get_guild_count();
+        metrics.active_games = stats.active_games;
+        metrics.moves_played = stats.moves_played;
+        metrics.games_finished = stats.games_finished;
+        return metrics;
+    });
     
     std::cout << "\n=== IMPORTANT INFORMATION ===" << std::endl;
     std::cout << "When inviting your bot to a server, make sure to use an invite URL that includes BOTH the 'bot' and 'applications.commands' scopes." << std::endl;
@@ -115,3 +130,50 @@ int main() {
     std::cout << "Bot has been stopped." << std::endl;
     return 0;
 }
+
+int main() {
+    std::cout << "=== Count Dracula Bot Starting ===" << std::endl;
+    
+    // Get token and guild ID from environment variables
+    const char* token = std::getenv("DISCORD_BOT_TOKEN");
+    const char* guild_id_str = std::getenv("DISCORD_GUILD_ID");
+
+    if (!token) {
+        std::cerr << "ERROR: DISCORD_BOT_TOKEN environment variable was not set." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "Token loaded successfully" << std::endl;
+    
+    // Parse guild ID if provided
+    dpp::snowflake guild_id = 0;
+    if (guild_id_str) {
+        try {
+            guild_id = std::stoull(guild_id_str);
+            std::cout << "Guild ID loaded from environment: " << guild_id << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "WARNING: Could not parse DISCORD_GUILD_ID as a number: " << e.what() << std::endl;
+        }
+    } else {
+        std::cout << "WARNING: DISCORD_GUILD_ID environment variable not set. Guild-specific commands will not be registered." << std::endl;
+    }
+    
+    // Create a timestamp for our logs
+    auto now = std::chrono::system_clock::now();
+    auto time_t_now = std::chrono::system_clock::to_time_t(now);
+    std::cout << "Bot startup time: " << std::put_time(std::localtime(&time_t_now), "%Y-%m-%d %H:%M:%S") << std::endl;
+
+    // COUNTDRACULA_WORKERS > 1 runs a supervisor that forks one process per worker.
+    // Games are kept per guild, and a guild only ever talks to its own shard, so
+    // each game lives in exactly one worker.
+    ShardConfig shard_config = ShardConfig::from_env();
+    if (!shard_config.is_sharded()) {
+        return run_bot(token, guild_id, shard_config, nullptr);
+    }
+    
+    ShardSupervisor supervisor(shard_config, [&](uint32_t worker_id) {
+        ShardIpcClient ipc(shard_config.ipc_path, worker_id);
+        return run_bot(token, guild_id, shard_config, &ipc);
+    });
+    return supervisor.run();
+}
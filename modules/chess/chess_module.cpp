@@ -1,4 +1,7 @@
 #include "chess_module.hpp"
+#include "replay_renderer.hpp"
+#include "speculator.hpp"
+#include "modules/trace.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -114,6 +117,8 @@ ChessPiece ChessBoard::get_piece(const Position& pos) const {
 }
 
 void ChessBoard::make_move(const Move& move) {
+    TRACE_SPAN("ChessBoard::make_move");
+    
     if (!is_legal_move(move)) {
         throw std::invalid_argument("Illegal move");
     }
@@ -196,6 +201,8 @@ std::vector<Move> ChessBoard::get_legal_moves() const {
 }
 
 bool ChessBoard::is_legal_move(const Move& move) const {
+    TRACE_SPAN("ChessBoard::is_legal_move");
+    
     auto legal_moves = get_legal_moves();
     return is_move_in_vector(move, legal_moves);
 }
@@ -206,6 +213,28 @@ bool ChessBoard::is_move_in_vector(const Move& move, const std::vector<Move>& mo
 
 // SVG generation for the chess board
 std::string ChessBoard::to_svg() const {
+    TRACE_SPAN("ChessBoard::to_svg");
+    
+    std::stringstream svg;
+    
+    svg << svg_header();
+    
+    // Draw the board squares
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            svg << svg_square(file, rank, board[file][rank]);
+        }
+    }
+    
+    svg << svg_labels();
+    
+    // Close the SVG
+    svg << "</svg>" << std::endl;
+    
+    return svg.str();
+}
+
+std::string ChessBoard::svg_header() {
     std::stringstream svg;
     
     // SVG header
@@ -215,56 +244,62 @@ std::string ChessBoard::to_svg() const {
     // Board background
     svg << "<rect width=\"400\" height=\"400\" fill=\"#8ca2ad\"/>" << std::endl;
     
-    // Draw the board squares
-    for (int rank = 0; rank < 8; rank++) {
-        for (int file = 0; file < 8; file++) {
-            int x = file * 50;
-            int y = (7 - rank) * 50;  // Flip the board so rank 1 is at the bottom
-            
-            bool is_light = (file + rank) % 2 == 0;
-            std::string color = is_light ? "#ffce9e" : "#d18b47";
-            
-            svg << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"50\" height=\"50\" fill=\"" << color << "\"/>" << std::endl;
-            
-            // Draw the piece if there is one
-            ChessPiece piece = board[file][rank];
-            if (!piece.is_empty()) {
-                std::string piece_symbol;
-                
-                // Map piece type to Unicode chess symbol
-                switch (piece.type) {
-                    case PieceType::PAWN:
-                        piece_symbol = (piece.color == PieceColor::WHITE) ? "♙" : "♟";
-                        break;
-                    case PieceType::KNIGHT:
-                        piece_symbol = (piece.color == PieceColor::WHITE) ? "♘" : "♞";
-                        break;
-                    case PieceType::BISHOP:
-                        piece_symbol = (piece.color == PieceColor::WHITE) ? "♗" : "♝";
-                        break;
-                    case PieceType::ROOK:
-                        piece_symbol = (piece.color == PieceColor::WHITE) ? "♖" : "♜";
-                        break;
-                    case PieceType::QUEEN:
-                        piece_symbol = (piece.color == PieceColor::WHITE) ? "♕" : "♛";
-                        break;
-                    case PieceType::KING:
-                        piece_symbol = (piece.color == PieceColor::WHITE) ? "♔" : "♚";
-                        break;
-                    default:
-                        piece_symbol = "";
-                }
-                
-                if (!piece_symbol.empty()) {
-                    svg << "<text x=\"" << (x + 25) << "\" y=\"" << (y + 35) 
-                        << "\" font-size=\"35\" text-anchor=\"middle\" fill=\"" 
-                        << (piece.color == PieceColor::WHITE ? "white" : "black") << "\">" 
-                        << piece_symbol << "</text>" << std::endl;
-                }
-            }
+    return svg.str();
+}
+
+std::string ChessBoard::svg_square(int file, int rank, const ChessPiece& piece) {
+    std::stringstream svg;
+    
+    int x = file * 50;
+    int y = (7 - rank) * 50;  // Flip the board so rank 1 is at the bottom
+    
+    bool is_light = (file + rank) % 2 == 0;
+    std::string color = is_light ? "#ffce9e" : "#d18b47";
+    
+    svg << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"50\" height=\"50\" fill=\"" << color << "\"/>" << std::endl;
+    
+    // Draw the piece if there is one
+    if (!piece.is_empty()) {
+        std::string piece_symbol;
+        
+        // Map piece type to Unicode chess symbol
+        switch (piece.type) {
+            case PieceType::PAWN:
+                piece_symbol = (piece.color == PieceColor::WHITE) ? "♙" : "♟";
+                break;
+            case PieceType::KNIGHT:
+                piece_symbol = (piece.color == PieceColor::WHITE) ? "♘" : "♞";
+                break;
+            case PieceType::BISHOP:
+                piece_symbol = (piece.color == PieceColor::WHITE) ? "♗" : "♝";
+                break;
+            case PieceType::ROOK:
+                piece_symbol = (piece.color == PieceColor::WHITE) ? "♖" : "♜";
+                break;
+            case PieceType::QUEEN:
+                piece_symbol = (piece.color == PieceColor::WHITE) ? "♕" : "♛";
+                break;
+            case PieceType::KING:
+                piece_symbol = (piece.color == PieceColor::WHITE) ? "♔" : "♚";
+                break;
+            default:
+                piece_symbol = "";
+        }
+        
+        if (!piece_symbol.empty()) {
+            svg << "<text x=\"" << (x + 25) << "\" y=\"" << (y + 35) 
+                << "\" font-size=\"35\" text-anchor=\"middle\" fill=\"" 
+                << (piece.color == PieceColor::WHITE ? "white" : "black") << "\">" 
+                << piece_symbol << "</text>" << std::endl;
         }
     }
     
+    return svg.str();
+}
+
+std::string ChessBoard::svg_labels() {
+    std::stringstream svg;
+    
     // Draw rank and file labels
     for (int i = 0; i < 8; i++) {
         // Rank labels (1-8)
@@ -276,14 +311,12 @@ std::string ChessBoard::to_svg() const {
             << char('a' + i) << "</text>" << std::endl;
     }
     
-    // Close the SVG
-    svg << "</svg>" << std::endl;
-    
     return svg.str();
 }
 
 // ChessModule implementation
-ChessModule::ChessModule(dpp::cluster& bot) : bot(bot), game_in_progress(false) {
+ChessModule::ChessModule(dpp::cluster& bot, UserCache& users) 
+    : bot(bot), users(users), active_games(0), moves_played(0), games_finished(0) {
     std::cout << "Initializing Chess Module..." << std::endl;
     
     // Register slash commands
@@ -291,6 +324,11 @@ ChessModule::ChessModule(dpp::cluster& bot) : bot(bot), game_in_progress(false)
     
     // Set up command handlers
     bot.on_slashcommand([this](const dpp::slashcommand_t& event) {
+        TRACE_SPAN("ChessModule::dispatch");
+        
+        // Every interaction carries user data for free, so keep the cache warm
+        this->users.fill_from_interaction(event.command);
+        
         std::cout << "Received slash command: " << event.command.get_command_name() << " from user: " 
                   << event.command.get_issuing_user().username << std::endl;
                   
@@ -300,6 +338,9 @@ ChessModule::ChessModule(dpp::cluster& bot) : bot(bot), game_in_progress(false)
         else if (event.command.get_command_name() == "move") {
             handle_move(event);
         }
+        else if (event.command.get_command_name() == "replay") {
+            handle_replay(event);
+        }
     });
     
     std::cout << "Chess Module initialized successfully!" << std::endl;
@@ -316,6 +357,23 @@ ChessModule::~ChessModule() {
     }
 }
 
+ChessModule::ChessGame& ChessModule::game_for(dpp::snowflake guild_id) {
+    std::lock_guard<std::mutex> lock(games_mutex);
+    ChessGame& game = games[guild_id];
+    if (!game.speculator) {
+        game.speculator = std::make_unique<MoveSpeculator>();
+    }
+    return game;
+}
+
+ChessStats ChessModule::get_stats() {
+    ChessStats stats;
+    stats.active_games = active_games;
+    stats.moves_played = moves_played;
+    stats.games_finished = games_finished;
+    return stats;
+}
+
 void ChessModule::register_commands() {
     std::cout << "Registering chess module commands..." << std::endl;
     
@@ -332,6 +390,9 @@ void ChessModule::register_commands() {
             dpp::command_option(dpp::co_string, "move", "The move in UCI notation (e.g., e2e4)", true)
         );
         
+        // Replay command
+        dpp::slashcommand replay_cmd("replay", "Show an animated replay of the last finished chess game", bot.me.id);
+        
         // Use guild-specific commands for faster testing (they appear instantly)
         const char* guild_id_str = std::getenv("DISCORD_GUILD_ID");
         if (guild_id_str) {
@@ -341,6 +402,7 @@ void ChessModule::register_commands() {
                 // Register guild-specific commands
                 bot.guild_command_create(start_cmd, guild_id);
                 bot.guild_command_create(move_cmd, guild_id);
+                bot.guild_command_create(replay_cmd, guild_id);
                 std::cout << "Registered guild-specific chess commands for guild ID: " << guild_id << std::endl;
             } catch (const std::exception& e) {
                 std::cerr << "WARNING: Could not parse DISCORD_GUILD_ID for chess module: " << e.what() << std::endl;
@@ -352,6 +414,7 @@ void ChessModule::register_commands() {
         // Also register globally (takes up to an hour to propagate)
         bot.global_command_create(start_cmd);
         bot.global_command_create(move_cmd);
+        bot.global_command_create(replay_cmd);
         std::cout << "Registered global commands (may take up to an hour to appear)" << std::endl;
         
     } catch (const std::exception& e) {
@@ -361,6 +424,8 @@ void ChessModule::register_commands() {
 
 std::string ChessModule::board_to_image(const ChessBoard& board, const std::string& white_player, 
                                       const std::string& black_player, int move_number) {
+    TRACE_SPAN("ChessModule::board_to_image");
+    
     std::string svg_data = board.to_svg();
     std::string timestamp = get_timestamp();
     std::string image_path = "/tmp/chess_board_" + timestamp + "_" + white_player + "_vs_" + 
@@ -371,6 +436,7 @@ std::string ChessModule::board_to_image(const ChessBoard& board, const std::stri
     if (svg_file.is_open()) {
         svg_file << svg_data;
         svg_file.close();
+        std::lock_guard<std::mutex> lock(images_mutex);
         board_images.push_back(image_path);
         return image_path;
     } else {
@@ -379,49 +445,83 @@ std::string ChessModule::board_to_image(const ChessBoard& board, const std::stri
 }
 
 void ChessModule::handle_start_chess(const dpp::slashcommand_t& event) {
-    if (game_in_progress) {
-        event.reply("A game is already in progress. Finish it first or wait.");
-        return;
+    ChessGame& game = game_for(event.command.guild_id);
+    
+    {
+        std::lock_guard<std::mutex> lock(game.mutex);
+        if (game.in_progress) {
+            event.reply("A game is already in progress. Finish it first or wait.");
+            return;
+        }
     }
     
     // Get opponent from parameters
     auto opponent_param = event.get_parameter("opponent");
     dpp::snowflake opponent_id = std::get<dpp::snowflake>(opponent_param);
+    dpp::snowflake challenger_id = event.command.get_issuing_user().id;
+    
+    // Both players normally arrive with the interaction itself (the issuer and the
+    // resolved user option), so this completes immediately with no REST call. A miss
+    // waits for user_get, which can outlast the 3 s reply deadline, so defer first.
+    event.thinking(true);
+    users.get({ challenger_id, opponent_id },
+              [this, event, challenger_id, opponent_id](const std::map<dpp::snowflake, CachedUser>& players) {
+        start_game(event, challenger_id, opponent_id, players);
+    });
+}
+
+void ChessModule::start_game(const dpp::slashcommand_t& event, dpp::snowflake challenger_id, dpp::snowflake opponent_id,
+                             const std::map<dpp::snowflake, CachedUser>& players) {
+    ChessGame& game = game_for(event.command.guild_id);
+    std::lock_guard<std::mutex> lock(game.mutex);
+    
+    // The lookup may have completed asynchronously, and another /start_chess may have
+    // won the race, so check again under the lock
+    if (game.in_progress) {
+        event.edit_response("A game is already in progress. Finish it first or wait.");
+        return;
+    }
     
     // Check if opponent is a bot
-    // In D++, checking if a user is a bot requires examining the user object
-    // For simplicity, we'll skip bot checking and just allow all users
-    // A more complete solution would use the user_get method with a callback
+    auto opponent = players.find(opponent_id);
+    if (opponent != players.end() && opponent->second.bot) {
+        event.edit_response("You can't play chess against a bot.");
+        return;
+    }
     
     // Start a new game
-    current_game = std::make_unique<ChessBoard>();
-    current_players = std::make_pair(event.command.get_issuing_user().id, opponent_id);
-    game_in_progress = true;
+    game.board = std::make_unique<ChessBoard>();
+    game.moves.clear();
+    game.speculator->start(*game.board);
+    game.players = std::make_pair(challenger_id, opponent_id);
+    game.in_progress = true;
+    active_games++;
     
     // Get user names
     std::string white_player_name = event.command.get_issuing_user().username;
-    std::string black_player_name = "Opponent"; // Default name
+    std::string black_player_name = (opponent != players.end()) ? opponent->second.username 
+                                                                : users.username_or_fetch(opponent_id);
     
     // Create board image
     std::string image_path;
     try {
-        image_path = board_to_image(*current_game, white_player_name, black_player_name, 0);
+        image_path = board_to_image(*game.board, white_player_name, black_player_name, 0);
     } catch (const std::exception& e) {
-        event.reply("Error generating board image: " + std::string(e.what()));
+        event.edit_response("Error generating board image: " + std::string(e.what()));
         return;
     }
     
     // Send start message
     std::string response = "New chess game started between <@" + 
-                           std::to_string(event.command.get_issuing_user().id) + 
+                           std::to_string(challenger_id) + 
                            "> (White) and <@" + std::to_string(opponent_id) + 
                            "> (Black)! Use `/move e2e4` to move.";
     
-    // Reply with message and file
-    event.thinking(true);
+    // Reply with message and file (the response was deferred in handle_start_chess)
     dpp::message msg(event.command.channel_id, response);
     msg.add_file("chessboard.svg", dpp::utility::read_file(image_path));
     bot.message_create(msg, [event](const dpp::confirmation_callback_t& callback) {
+        TRACE_SPAN("ChessModule::message_create callback");
         if (callback.is_error()) {
             event.edit_response("Error sending board image");
         }
@@ -430,20 +530,23 @@ void ChessModule::handle_start_chess(const dpp::slashcommand_t& event) {
 }
 
 void ChessModule::handle_move(const dpp::slashcommand_t& event) {
-    if (!game_in_progress || !current_game) {
+    ChessGame& game = game_for(event.command.guild_id);
+    std::lock_guard<std::mutex> lock(game.mutex);
+    
+    if (!game.in_progress || !game.board) {
         event.reply("No game in progress. Use `/start_chess @user` to begin.");
         return;
     }
     
     dpp::snowflake user_id = event.command.get_issuing_user().id;
-    if (user_id != current_players.first && user_id != current_players.second) {
+    if (user_id != game.players.first && user_id != game.players.second) {
         event.reply("You are not a player in the current chess game.");
         return;
     }
     
     // Check whose turn it is
-    bool is_white_turn = current_game->get_turn() == PieceColor::WHITE;
-    dpp::snowflake current_turn_player = is_white_turn ? current_players.first : current_players.second;
+    bool is_white_turn = game.board->get_turn() == PieceColor::WHITE;
+    dpp::snowflake current_turn_player = is_white_turn ? game.players.first : game.players.second;
     
     if (user_id != current_turn_player) {
         event.reply("It's not your turn.");
@@ -458,42 +561,64 @@ void ChessModule::handle_move(const dpp::slashcommand_t& event) {
         // Parse the move
         Move chess_move = Move::from_uci(move_str);
         
+        // A reply predicted during the opponent's turn is already played and rendered
+        std::string board_svg;
+        bool predicted = game.speculator->take(chess_move, *game.board, board_svg);
+        
         // Check if the move is legal
-        if (current_game->is_legal_move(chess_move)) {
+        if (predicted || game.board->is_legal_move(chess_move)) {
             // Make the move
-            current_game->make_move(chess_move);
+            if (!predicted) {
+                game.speculator->cancel();
+                game.board->make_move(chess_move);
+            }
+            game.moves.push_back(chess_move);
+            moves_played++;
             
-            // Get player names
-            std::string white_player_name = "White Player";
-            std::string black_player_name = "Black Player";
+            // Get player names (cached from earlier interactions, no REST call)
+            std::string white_player_name = users.username_or_fetch(game.players.first);
+            std::string black_player_name = users.username_or_fetch(game.players.second);
             
             // Create board image
-            int move_number = current_game->get_fullmove_number();
+            int move_number = game.board->get_fullmove_number();
             event.thinking(true);
             
-            std::string image_path;
-            try {
-                image_path = board_to_image(*current_game, white_player_name, black_player_name, move_number);
-            } catch (const std::exception& e) {
-                event.edit_response("Error generating board image: " + std::string(e.what()));
-                return;
+            if (!predicted) {
+                try {
+                    std::string image_path = board_to_image(*game.board, white_player_name, black_player_name, move_number);
+                    board_svg = dpp::utility::read_file(image_path);
+                } catch (const std::exception& e) {
+                    event.edit_response("Error generating board image: " + std::string(e.what()));
+                    return;
+                }
             }
             
             // Send move message
-            std::string response = "Move made: " + move_str;
+            std::string response = "Move made by " + users.display_name(event.command.guild_id, user_id) + 
+                                   ": " + move_str;
             
             // Add game over info if applicable
-            if (current_game->is_game_over()) {
-                response += "\nGame over! Result: " + current_game->get_result();
-                game_in_progress = false;
-                current_game.reset();
+            if (game.board->is_game_over()) {
+                response += "\nGame over! Result: " + game.board->get_result();
+                response += "\nUse `/replay` to watch the whole game.";
+                game.last_moves = std::move(game.moves);
+                game.last_result = game.board->get_result();
+                game.moves.clear();
+                game.in_progress = false;
+                active_games--;
+                games_finished++;
+                game.board.reset();
+            } else {
+                // Get a head start on the next player's likely replies
+                game.speculator->start(*game.board);
             }
             
             // Reply with message and file
             dpp::message msg(event.command.channel_id, response);
-            msg.add_file("chessboard.svg", dpp::utility::read_file(image_path));
+            msg.add_file("chessboard.svg", board_svg);
             
             bot.message_create(msg, [event](const dpp::confirmation_callback_t& callback) {
+                TRACE_SPAN("ChessModule::message_create callback");
                 if (callback.is_error()) {
                     event.edit_response("Error sending board image");
                 }
@@ -508,3 +633,49 @@ void ChessModule::handle_move(const dpp::slashcommand_t& event) {
         event.reply("Invalid move format. Use standard UCI (e.g., e2e4). Error: " + std::string(e.what()));
     }
 }
+
+void ChessModule::handle_replay(const dpp::slashcommand_t& event) {
+    ChessGame& game = game_for(event.command.guild_id);
+    
+    // Copy the finished game so rendering does not hold up moves in this guild
+    std::vector<Move> last_moves;
+    std::string last_result;
+    {
+        std::lock_guard<std::mutex> lock(game.mutex);
+        last_moves = game.last_moves;
+        last_result = game.last_result;
+    }
+    
+    if (last_moves.empty()) {
+        event.reply("No finished game to replay yet.");
+        return;
+    }
+    
+    event.thinking(true);
+    
+    std::string replay_svg;
+    try {
+        auto start = std::chrono::steady_clock::now();
+        replay_svg = render_replay_svg(last_moves);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "Rendered replay of " << last_moves.size() << " moves in " << elapsed.count() << " ms" << std::endl;
+    } catch (const std::exception& e) {
+        event.edit_response("Error rendering replay: " + std::string(e.what()));
+        return;
+    }
+    
+    // The replay is attached straight from memory, no temp file needed
+    std::string response = "Replay of the last game (" + std::to_string(last_moves.size()) + 
+                           " moves, result " + last_result + ")";
+    dpp::message msg(event.command.channel_id, response);
+    msg.add_file("replay.svg", replay_svg);
+    
+    bot.message_create(msg, [event](const dpp::confirmation_callback_t& callback) {
+        TRACE_SPAN("ChessModule::message_create callback");
+        if (callback.is_error()) {
+            event.edit_response("Error sending replay");
+        }
+    });
+    
+    event.edit_response("Replay rendered!");
+}
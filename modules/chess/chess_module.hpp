@@ -9,32 +9,76 @@
 #include <ctime>
 #include <iomanip>
 #include <sstream>
+#include <mutex>
+#include <atomic>
+#include "modules/user_cache.hpp"
 
-// Forward declaration for the Chess board class
+// Forward declarations
 class ChessBoard;
+class MoveSpeculator;
+struct Move;
+
+// Game counters reported by ChessModule
+struct ChessStats {
+    size_t active_games;
+    uint64_t moves_played;
+    uint64_t games_finished;
+};
 
 class ChessModule {
 private:
+    // State of the chess game in one guild. Handlers hold `mutex` for their whole
+    // check-and-update sequence, since D++ runs events (and REST callbacks) on a pool.
+    struct ChessGame {
+        std::mutex mutex;
+        std::unique_ptr<ChessBoard> board;
+        std::pair<dpp::snowflake, dpp::snowflake> players;
+        std::vector<Move> moves;
+        bool in_progress = false;
+        
+        // Background precomputation of the next player's likely replies
+        std::unique_ptr<MoveSpeculator> speculator;
+        
+        // Last finished game, kept for /replay
+        std::vector<Move> last_moves;
+        std::string last_result;
+    };
+    
     dpp::cluster& bot;
+    UserCache& users;
+    
+    // Game state, one game per guild. Entries are never erased, so references
+    // returned by game_for() stay valid. games_mutex only guards the map itself.
+    std::unordered_map<dpp::snowflake, ChessGame> games;
+    std::mutex games_mutex;
+    
+    // Counters for get_stats(), read without any game lock. active_games only
+    // changes together with a game's in_progress flag, under that game's mutex.
+    std::atomic<uint64_t> active_games;
+    std::atomic<uint64_t> moves_played;
+    std::atomic<uint64_t> games_finished;
     
-    // Game state
-    std::unique_ptr<ChessBoard> current_game;
-    std::pair<dpp::snowflake, dpp::snowflake> current_players;
     std::vector<std::string> board_images;
-    bool game_in_progress;
+    std::mutex images_mutex;
     
     // Helper methods
+    ChessGame& game_for(dpp::snowflake guild_id);
     std::string board_to_image(const ChessBoard& board, const std::string& white_player, 
                               const std::string& black_player, int move_number);
     void register_commands();
     
     // Command handlers
     void handle_start_chess(const dpp::slashcommand_t& event);
+    void start_game(const dpp::slashcommand_t& event, dpp::snowflake challenger_id, dpp::snowflake opponent_id,
+                    const std::map<dpp::snowflake, CachedUser>& players);
     void handle_move(const dpp::slashcommand_t& event);
+    void handle_replay(const dpp::slashcommand_t& event);
     
 public:
-    ChessModule(dpp::cluster& bot);
+    ChessModule(dpp::cluster& bot, UserCache& users);
     ~ChessModule();
+    
+    ChessStats get_stats();
 };
 
 // Chess piece type
@@ -132,6 +176,11 @@ public:
     // SVG generation
     std::string to_svg() const;
     
+    // SVG fragments shared by to_svg and the replay renderer
+    static std::string svg_header();
+    static std::string svg_square(int file, int rank, const ChessPiece& piece);
+    static std::string svg_labels();
+    
     // Other helpers
     static bool is_move_in_vector(const Move& move, const std::vector<Move>& moves);
 };
@@ -0,0 +1,240 @@
+#include "move_batch.hpp"
+#include "chess_module.hpp"
+#include <chrono>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+const uint64_t FILE_A = 0x0101010101010101ULL;
+const uint64_t FILE_H = 0x8080808080808080ULL;
+const uint64_t RANK_3 = 0x0000000000FF0000ULL;
+const uint64_t RANK_6 = 0x0000FF0000000000ULL;
+
+// Pawn target squares for one block of positions. Each loop is branch-free
+// over the positions (both colours are computed and blended by the side-to-move
+// mask) and every array is 64-bit wide and unaliased, which lets the compiler
+// vectorize it.
+struct PawnTargets {
+    std::vector<uint64_t> push;
+    std::vector<uint64_t> double_push;
+    std::vector<uint64_t> capture_west;  // towards file a
+    std::vector<uint64_t> capture_east;  // towards file h
+};
+
+// Inner loop of compute_pawn_targets. The pointers are parameters rather than locals
+// because GCC only honours __restrict__ on parameters; without it the loop needs
+// runtime alias checks across eight arrays and is left scalar.
+void pawn_targets_kernel(size_t count,
+                         const uint64_t* __restrict__ wp, const uint64_t* __restrict__ bp,
+                         const uint64_t* __restrict__ wo, const uint64_t* __restrict__ bo,
+                         const uint64_t* __restrict__ stm,
+                         uint64_t* __restrict__ push, uint64_t* __restrict__ double_push,
+                         uint64_t* __restrict__ west, uint64_t* __restrict__ east) {
+    for (size_t i = 0; i < count; i++) {
+        uint64_t white = stm[i];
+        uint64_t empty = ~(wo[i] | bo[i]);
+
+        uint64_t w_push = (wp[i] << 8) & empty;
+        uint64_t b_push = (bp[i] >> 8) & empty;
+        uint64_t w_double = ((w_push & RANK_3) << 8) & empty;
+        uint64_t b_double = ((b_push & RANK_6) >> 8) & empty;
+        uint64_t w_west = ((wp[i] & ~FILE_A) << 7) & bo[i];
+        uint64_t b_west = ((bp[i] & ~FILE_A) >> 9) & wo[i];
+        uint64_t w_east = ((wp[i] & ~FILE_H) << 9) & bo[i];
+        uint64_t b_east = ((bp[i] & ~FILE_H) >> 7) & wo[i];
+
+        push[i] = (w_push & white) | (b_push & ~white);
+        double_push[i] = (w_double & white) | (b_double & ~white);
+        west[i] = (w_west & white) | (b_west & ~white);
+        east[i] = (w_east & white) | (b_east & ~white);
+    }
+}
+
+PawnTargets compute_pawn_targets(const PositionBatch& batch) {
+    size_t count = batch.size();
+    PawnTargets targets;
+    targets.push.resize(count);
+    targets.double_push.resize(count);
+    targets.capture_west.resize(count);
+    targets.capture_east.resize(count);
+
+    pawn_targets_kernel(count,
+                        batch.white_pawns.data(), batch.black_pawns.data(),
+                        batch.white_pieces.data(), batch.black_pieces.data(),
+                        batch.white_to_move.data(),
+                        targets.push.data(), targets.double_push.data(),
+                        targets.capture_west.data(), targets.capture_east.data());
+
+    return targets;
+}
+
+Position square_to_position(int square) {
+    return Position(square % 8, square / 8);
+}
+
+// Emit one move per set bit of targets, with the origin at a fixed offset from the target
+void append_moves(std::vector<Move>& moves, uint64_t targets, int from_offset) {
+    while (targets) {
+        int to = __builtin_ctzll(targets);
+        targets &= targets - 1;
+        moves.push_back(Move(square_to_position(to - from_offset), square_to_position(to)));
+    }
+}
+
+} // namespace
+
+void PositionBatch::reserve(size_t count) {
+    white_pawns.reserve(count);
+    black_pawns.reserve(count);
+    white_pieces.reserve(count);
+    black_pieces.reserve(count);
+    white_to_move.reserve(count);
+}
+
+void PositionBatch::clear() {
+    white_pawns.clear();
+    black_pawns.clear();
+    white_pieces.clear();
+    black_pieces.clear();
+    white_to_move.clear();
+}
+
+void PositionBatch::add(const ChessBoard& board) {
+    uint64_t wp = 0, bp = 0, wo = 0, bo = 0;
+
+    for (int file = 0; file < 8; file++) {
+        for (int rank = 0; rank < 8; rank++) {
+            ChessPiece piece = board.get_piece(Position(file, rank));
+            if (piece.is_empty()) {
+                continue;
+            }
+            uint64_t bit = 1ULL << (rank * 8 + file);
+            bool is_pawn = piece.type == PieceType::PAWN;
+            if (piece.color == PieceColor::WHITE) {
+                wo |= bit;
+                if (is_pawn) wp |= bit;
+            } else {
+                bo |= bit;
+                if (is_pawn) bp |= bit;
+            }
+        }
+    }
+
+    white_pawns.push_back(wp);
+    black_pawns.push_back(bp);
+    white_pieces.push_back(wo);
+    black_pieces.push_back(bo);
+    white_to_move.push_back(board.get_turn() == PieceColor::WHITE ? ~0ULL : 0);
+}
+
+BatchMoves generate_moves_batch(const PositionBatch& batch) {
+    size_t count = batch.size();
+    PawnTargets targets = compute_pawn_targets(batch);
+
+    BatchMoves result;
+    result.offsets.reserve(count + 1);
+    result.offsets.push_back(0);
+
+    // Size the output up front so the serialization loop never reallocates
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += __builtin_popcountll(targets.push[i]) + __builtin_popcountll(targets.double_push[i]) +
+                 __builtin_popcountll(targets.capture_west[i]) + __builtin_popcountll(targets.capture_east[i]);
+    }
+    result.moves.reserve(total);
+
+    for (size_t i = 0; i < count; i++) {
+        int dir = batch.white_to_move[i] ? 1 : -1;
+        append_moves(result.moves, targets.push[i], 8 * dir);
+        append_moves(result.moves, targets.double_push[i], 16 * dir);
+        append_moves(result.moves, targets.capture_west[i], batch.white_to_move[i] ? 7 : -9);
+        append_moves(result.moves, targets.capture_east[i], batch.white_to_move[i] ? 9 : -7);
+        result.offsets.push_back(static_cast<uint32_t>(result.moves.size()));
+    }
+
+    return result;
+}
+
+std::vector<uint8_t> validate_moves_batch(const PositionBatch& batch, const std::vector<Move>& moves) {
+    if (moves.size() != batch.size()) {
+        throw std::invalid_argument("Move count does not match batch size");
+    }
+
+    size_t count = batch.size();
+    PawnTargets targets = compute_pawn_targets(batch);
+    std::vector<uint8_t> results(count, 0);
+
+    for (size_t i = 0; i < count; i++) {
+        const Move& move = moves[i];
+        if (!move.from.is_valid() || !move.to.is_valid()) {
+            continue;
+        }
+
+        int from = move.from.rank * 8 + move.from.file;
+        int to = move.to.rank * 8 + move.to.file;
+        uint64_t to_bit = 1ULL << to;
+        uint64_t pawns = batch.white_to_move[i] ? batch.white_pawns[i] : batch.black_pawns[i];
+        int delta = batch.white_to_move[i] ? (to - from) : (from - to);
+
+        // The origin must hold a pawn of the side to move, and the target must be in
+        // the set generated for exactly that kind of pawn move
+        bool legal = false;
+        if (pawns & (1ULL << from)) {
+            bool west = batch.white_to_move[i] ? delta == 7 : delta == 9;
+            bool east = batch.white_to_move[i] ? delta == 9 : delta == 7;
+            legal = (delta == 8 && (targets.push[i] & to_bit)) ||
+                    (delta == 16 && (targets.double_push[i] & to_bit)) ||
+                    (west && (targets.capture_west[i] & to_bit)) ||
+                    (east && (targets.capture_east[i] & to_bit));
+        }
+        results[i] = legal ? 1 : 0;
+    }
+
+    return results;
+}
+
+PositionBatch build_benchmark_corpus(size_t positions, unsigned seed) {
+    PositionBatch corpus;
+    corpus.reserve(positions);
+
+    std::mt19937 rng(seed);
+    ChessBoard board;
+
+    while (corpus.size() < positions) {
+        corpus.add(board);
+
+        auto legal_moves = board.get_legal_moves();
+        if (legal_moves.empty() || board.is_game_over()) {
+            board = ChessBoard();
+            continue;
+        }
+
+        std::uniform_int_distribution<size_t> pick(0, legal_moves.size() - 1);
+        board.make_move(legal_moves[pick(rng)]);
+        if (board.is_game_over()) {
+            board = ChessBoard();
+        }
+    }
+
+    return corpus;
+}
+
+BatchStats benchmark_moves_batch(const PositionBatch& corpus, int iterations) {
+    size_t generated = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        BatchMoves moves = generate_moves_batch(corpus);
+        generated += moves.moves.size();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    BatchStats stats;
+    stats.positions = corpus.size() * static_cast<size_t>(iterations);
+    stats.seconds = std::chrono::duration<double>(end - start).count();
+    stats.moves = generated;
+    stats.positions_per_sec = stats.seconds > 0 ? stats.positions / stats.seconds : 0.0;
+
+    return stats;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+class ChessBoard;
+struct Move;
+
+// Structure-of-arrays block of positions for bulk move generation and validation.
+// Each position is stored as bitboards (bit index = rank * 8 + file), one array per field,
+// so the per-position work can be done in tight loops the compiler can vectorize.
+struct PositionBatch {
+    std::vector<uint64_t> white_pawns;
+    std::vector<uint64_t> black_pawns;
+    std::vector<uint64_t> white_pieces;  // all white occupancy, pawns included
+    std::vector<uint64_t> black_pieces;  // all black occupancy, pawns included
+    std::vector<uint64_t> white_to_move;  // all ones if white is to move, zero otherwise
+
+    size_t size() const { return white_to_move.size(); }
+    void reserve(size_t count);
+    void clear();
+
+    // Append a position
+    void add(const ChessBoard& board);
+};
+
+// Moves for a whole batch in compressed-row layout: the moves of position i
+// are moves[offsets[i]] .. moves[offsets[i + 1] - 1]
+struct BatchMoves {
+    std::vector<uint32_t> offsets;
+    std::vector<Move> moves;
+};
+
+// Throughput of a batch run
+struct BatchStats {
+    size_t positions;
+    size_t moves;
+    double seconds;
+    double positions_per_sec;
+};
+
+// Generate the legal moves of every position in the batch.
+// Follows the same rules as ChessBoard::get_legal_moves(), though not necessarily in the same order.
+BatchMoves generate_moves_batch(const PositionBatch& batch);
+
+// Check moves[i] against position i; results[i] is 1 if legal, 0 otherwise
+std::vector<uint8_t> validate_moves_batch(const PositionBatch& batch, const std::vector<Move>& moves);
+
+// Build a corpus of positions reached by random playouts from the starting position
+PositionBatch build_benchmark_corpus(size_t positions, unsigned seed = 1);
+
+// Time generate_moves_batch over the corpus
+BatchStats benchmark_moves_batch(const PositionBatch& corpus, int iterations = 10);
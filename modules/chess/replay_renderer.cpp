@@ -0,0 +1,99 @@
+#include "replay_renderer.hpp"
+#include "chess_module.hpp"
+#include <sstream>
+#include <thread>
+#include <algorithm>
+
+namespace {
+
+bool same_piece(const ChessPiece& a, const ChessPiece& b) {
+    return a.type == b.type && a.color == b.color;
+}
+
+// Encode frames [first, last) as deltas against their predecessor. Each changed
+// square is drawn hidden and made visible when its frame begins; later frames
+// come later in the document, so they paint over earlier ones.
+std::string encode_frames(const std::vector<ChessBoard>& positions, size_t first, size_t last,
+                          double frame_seconds) {
+    std::stringstream svg;
+
+    for (size_t frame = first; frame < last; frame++) {
+        const ChessBoard& previous = positions[frame - 1];
+        const ChessBoard& current = positions[frame];
+
+        for (int rank = 0; rank < 8; rank++) {
+            for (int file = 0; file < 8; file++) {
+                Position pos(file, rank);
+                ChessPiece piece = current.get_piece(pos);
+                if (same_piece(piece, previous.get_piece(pos))) {
+                    continue;
+                }
+
+                svg << "<g visibility=\"hidden\"><set attributeName=\"visibility\" to=\"visible\" begin=\""
+                    << (frame * frame_seconds) << "s\" fill=\"freeze\"/>" << std::endl;
+                svg << ChessBoard::svg_square(file, rank, piece);
+                svg << "</g>" << std::endl;
+            }
+        }
+    }
+
+    return svg.str();
+}
+
+} // namespace
+
+std::string render_replay_svg(const std::vector<Move>& moves, unsigned threads, double frame_seconds) {
+    // Replaying the moves is cheap next to SVG encoding, so positions are
+    // reconstructed serially and only the frame encoding is parallelized
+    std::vector<ChessBoard> positions;
+    positions.reserve(moves.size() + 1);
+    positions.emplace_back();
+    for (const Move& move : moves) {
+        ChessBoard next = positions.back();
+        next.make_move(move);
+        positions.push_back(std::move(next));
+    }
+
+    size_t frame_count = positions.size();
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t workers = std::min<size_t>(threads, frame_count - 1);
+
+    // Split frames 1..N-1 into contiguous chunks so the fragments concatenate in order
+    std::vector<std::string> fragments(workers);
+    std::vector<std::thread> pool;
+    size_t per_worker = workers ? (frame_count - 1 + workers - 1) / workers : 0;
+    for (size_t w = 0; w < workers; w++) {
+        size_t first = 1 + w * per_worker;
+        size_t last = std::min(frame_count, first + per_worker);
+        if (first >= last) {
+            break;
+        }
+        pool.emplace_back([&positions, &fragments, w, first, last, frame_seconds]() {
+            fragments[w] = encode_frames(positions, first, last, frame_seconds);
+        });
+    }
+
+    // The first frame is the full starting board, encoded while the workers run
+    std::stringstream svg;
+    svg << ChessBoard::svg_header();
+    for (int rank = 0; rank < 8; rank++) {
+        for (int file = 0; file < 8; file++) {
+            svg << ChessBoard::svg_square(file, rank, positions.front().get_piece(Position(file, rank)));
+        }
+    }
+
+    for (auto& worker : pool) {
+        worker.join();
+    }
+    for (const auto& fragment : fragments) {
+        svg << fragment;
+    }
+
+    // Labels go last so changed edge squares never cover them
+    svg << ChessBoard::svg_labels();
+    svg << "</svg>" << std::endl;
+
+    return svg.str();
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <string>
+#include <vector>
+
+struct Move;
+
+// Render a whole game as a single animated SVG (SMIL), one frame per position.
+// The first frame is the full starting board; every later frame only carries the
+// squares that changed since the previous position. Frames are encoded in
+// parallel across `threads` workers (0 = one per hardware thread).
+// Throws std::invalid_argument if the move list is not a legal game.
+std::string render_replay_svg(const std::vector<Move>& moves, unsigned threads = 0,
+                              double frame_seconds = 1.0);
@@ -0,0 +1,126 @@
+#include "speculator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+int capture_value(PieceType type) {
+    switch (type) {
+        case PieceType::QUEEN:  return 9;
+        case PieceType::ROOK:   return 5;
+        case PieceType::BISHOP: return 3;
+        case PieceType::KNIGHT: return 3;
+        case PieceType::PAWN:   return 1;
+        default:                return 0;
+    }
+}
+
+// Cheap guess at how likely a reply is: captures first, then central and double pawn pushes
+double reply_score(const ChessBoard& board, const Move& move) {
+    double score = 0.0;
+
+    ChessPiece target = board.get_piece(move.to);
+    if (!target.is_empty()) {
+        score += 10.0 * capture_value(target.type);
+    }
+    if (std::abs(move.to.rank - move.from.rank) == 2) {
+        score += 2.0;
+    }
+    score += 3.5 - std::abs(move.to.file - 3.5);
+
+    return score;
+}
+
+} // namespace
+
+MoveSpeculator::MoveSpeculator(size_t max_replies, size_t exhaustive_limit)
+    : max_replies(max_replies), exhaustive_limit(exhaustive_limit), cancelled(false) {
+}
+
+MoveSpeculator::~MoveSpeculator() {
+    cancel();
+}
+
+std::vector<Move> MoveSpeculator::select_replies(const ChessBoard& board) const {
+    std::vector<Move> replies = board.get_legal_moves();
+    if (replies.size() <= exhaustive_limit) {
+        return replies;
+    }
+
+    std::vector<std::pair<double, Move>> scored;
+    scored.reserve(replies.size());
+    for (const Move& move : replies) {
+        scored.emplace_back(reply_score(board, move), move);
+    }
+    std::stable_sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+
+    replies.clear();
+    for (size_t i = 0; i < scored.size() && i < max_replies; i++) {
+        replies.push_back(scored[i].second);
+    }
+    return replies;
+}
+
+void MoveSpeculator::run(ChessBoard board) {
+    std::vector<Move> replies = select_replies(board);
+
+    for (const Move& move : replies) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        try {
+            Prediction prediction{ board, "" };
+            prediction.board.make_move(move);
+            prediction.svg = prediction.board.to_svg();
+
+            std::lock_guard<std::mutex> lock(predictions_mutex);
+            predictions.emplace(move.to_uci(), std::move(prediction));
+        } catch (const std::exception& e) {
+            std::cerr << "Speculation failed for " << move.to_uci() << ": " << e.what() << std::endl;
+        }
+    }
+}
+
+void MoveSpeculator::stop_worker() {
+    cancelled = true;
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    std::lock_guard<std::mutex> lock(predictions_mutex);
+    predictions.clear();
+}
+
+void MoveSpeculator::start(const ChessBoard& board) {
+    std::lock_guard<std::mutex> control(control_mutex);
+    stop_worker();
+
+    cancelled = false;
+    worker = std::thread(&MoveSpeculator::run, this, board);
+}
+
+bool MoveSpeculator::take(const Move& move, ChessBoard& board, std::string& svg) {
+    std::lock_guard<std::mutex> control(control_mutex);
+
+    {
+        std::lock_guard<std::mutex> lock(predictions_mutex);
+        auto it = predictions.find(move.to_uci());
+        if (it == predictions.end()) {
+            return false;
+        }
+        board = std::move(it->second.board);
+        svg = std::move(it->second.svg);
+    }
+
+    stop_worker();
+    return true;
+}
+
+void MoveSpeculator::cancel() {
+    std::lock_guard<std::mutex> control(control_mutex);
+    stop_worker();
+}
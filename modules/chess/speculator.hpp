@@ -0,0 +1,51 @@
+#pragma once
+#include "chess_module.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+// Precomputes likely replies in the background while the bot waits for the next /move.
+// For each candidate reply the successor position and its SVG are cached, so an
+// accepted move that was predicted needs no move generation or rendering at all.
+class MoveSpeculator {
+private:
+    struct Prediction {
+        ChessBoard board;
+        std::string svg;
+    };
+
+    size_t max_replies;       // top-N replies kept when there are many
+    size_t exhaustive_limit;  // at or below this many replies, all are precomputed
+
+    std::unordered_map<std::string, Prediction> predictions;
+    std::mutex predictions_mutex;
+
+    std::thread worker;
+    std::atomic<bool> cancelled;
+    std::mutex control_mutex;
+
+    void run(ChessBoard board);
+    void stop_worker();
+    std::vector<Move> select_replies(const ChessBoard& board) const;
+
+public:
+    explicit MoveSpeculator(size_t max_replies = 8, size_t exhaustive_limit = 12);
+    ~MoveSpeculator();
+
+    MoveSpeculator(const MoveSpeculator&) = delete;
+    MoveSpeculator& operator=(const MoveSpeculator&) = delete;
+
+    // Discard any previous speculation and start precomputing replies to this position
+    void start(const ChessBoard& board);
+
+    // Claim the precomputed result for the move actually played and discard the rest.
+    // Returns false, leaving the speculation running, if the move was not predicted
+    // (or not finished in time); call cancel() once a different move is accepted.
+    bool take(const Move& move, ChessBoard& board, std::string& svg);
+
+    // Stop the background work and drop all predictions
+    void cancel();
+};
@@ -1,10 +1,12 @@
 #include "greetings_module.hpp"
+#include "trace.hpp"
 #include <iostream>
 
 GreetingsModule::GreetingsModule(dpp::cluster& bot) {
     std::cout << "Initializing Greetings Module..." << std::endl;
     
     bot.on_slashcommand([&bot](const dpp::slashcommand_t& event) {
+        TRACE_SPAN("GreetingsModule::dispatch");
         if (event.command.get_command_name() == "hello") {
             std::cout << "Received /hello command from user: " << event.command.get_issuing_user().username << std::endl;
             event.reply("Hello world from the greetings module!");
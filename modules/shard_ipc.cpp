@@ -0,0 +1,442 @@
+#include "shard_ipc.hpp"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+namespace {
+
+// Workers that have not reported for this long are left out of the totals
+const std::chrono::seconds REPORT_TIMEOUT(30);
+
+// A worker that dies sooner than this after starting is restarted with a delay
+const std::chrono::seconds MIN_UPTIME(5);
+
+std::atomic<bool> stop_requested(false);
+std::atomic<bool> trace_dump_requested(false);
+
+void handle_stop_signal(int) {
+    stop_requested.store(true);
+}
+
+void handle_trace_signal(int) {
+    trace_dump_requested.store(true);
+}
+
+uint32_t env_uint(const char* name, uint32_t fallback) {
+    const char* value = std::getenv(name);
+    if (!value) {
+        return fallback;
+    }
+    try {
+        return static_cast<uint32_t>(std::stoul(value));
+    } catch (const std::exception& e) {
+        std::cerr << "WARNING: Could not parse " << name << ": " << e.what() << std::endl;
+        return fallback;
+    }
+}
+
+bool fill_address(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return true;
+}
+
+bool write_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+ShardConfig ShardConfig::from_env() {
+    ShardConfig config;
+    config.workers = std::max<uint32_t>(1, env_uint("COUNTDRACULA_WORKERS", 1));
+    config.shards = std::max(config.workers, env_uint("COUNTDRACULA_SHARDS", config.workers));
+    const char* path = std::getenv("COUNTDRACULA_IPC_PATH");
+    config.ipc_path = path ? path : "/tmp/countdracula.sock";
+    config.spawn_interval = std::chrono::milliseconds(env_uint("COUNTDRACULA_SPAWN_INTERVAL_MS", 5000));
+    return config;
+}
+
+uint32_t shard_for_guild(uint64_t guild_id, uint32_t shards) {
+    return shards ? static_cast<uint32_t>((guild_id >> 22) % shards) : 0;
+}
+
+uint32_t worker_for_guild(uint64_t guild_id, const ShardConfig& config) {
+    return shard_for_guild(guild_id, config.shards) % config.workers;
+}
+
+// ShardSupervisor implementation
+ShardSupervisor::ShardSupervisor(const ShardConfig& config, worker_main_t worker_main)
+    : config(config), worker_main(worker_main), listen_fd(-1), workers(config.workers) {
+}
+
+bool ShardSupervisor::open_socket() {
+    sockaddr_un addr;
+    if (!fill_address(config.ipc_path, addr)) {
+        std::cerr << "ERROR: IPC socket path is too long: " << config.ipc_path << std::endl;
+        return false;
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        std::cerr << "ERROR: Could not create IPC socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    unlink(config.ipc_path.c_str());
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd, 16) < 0) {
+        std::cerr << "ERROR: Could not listen on " << config.ipc_path << ": " << std::strerror(errno) << std::endl;
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void ShardSupervisor::spawn(uint32_t worker_id) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "ERROR: Could not fork worker " << worker_id << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    if (pid == 0) {
+        // Child: drop the supervisor's sockets and run the bot for our shards
+        close(listen_fd);
+        for (const auto& connection : connections) {
+            close(connection.fd);
+        }
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        // The worker installs its trace-dump handler only once the cluster is built;
+        // until then a forwarded SIGUSR1 must not kill it with the default action
+        std::signal(SIGUSR1, SIG_IGN);
+        std::_Exit(worker_main(worker_id));
+    }
+
+    WorkerState& worker = workers[worker_id];
+    worker.pid = pid;
+    worker.started = std::chrono::steady_clock::now();
+    last_spawn = worker.started;
+    worker.has_report = false;
+    std::cout << "Started worker " << worker_id << " (PID " << pid << ")" << std::endl;
+}
+
+void ShardSupervisor::reap_and_start() {
+    int status = 0;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        for (uint32_t id = 0; id < workers.size(); id++) {
+            if (workers[id].pid == pid) {
+                std::cerr << "Worker " << id << " (PID " << pid << ") exited with status " << status << std::endl;
+                workers[id].pid = 0;
+            }
+        }
+    }
+
+    // Start at most one worker per spawn interval, first-time starts and restarts alike
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_spawn < config.spawn_interval) {
+        return;
+    }
+    for (uint32_t id = 0; id < workers.size(); id++) {
+        // Back off a little if a worker keeps crashing right after starting
+        bool never_started = workers[id].started == std::chrono::steady_clock::time_point();
+        if (workers[id].pid == 0 && (never_started || now - workers[id].started >= MIN_UPTIME)) {
+            spawn(id);
+            return;
+        }
+    }
+}
+
+void ShardSupervisor::handle_line(int fd, const std::string& line) {
+    std::istringstream in(line);
+    std::string command;
+    in >> command;
+
+    if (command == "METRICS") {
+        uint32_t id = 0;
+        WorkerMetrics metrics;
+        in >> id >> metrics.guilds >> metrics.active_games >> metrics.moves_played >> metrics.games_finished;
+        if (in && id < workers.size()) {
+            workers[id].metrics = metrics;
+            workers[id].reported = std::chrono::steady_clock::now();
+            workers[id].has_report = true;
+        }
+    } else if (command == "TOTALS") {
+        WorkerMetrics totals;
+        uint32_t reporting = 0;
+        auto now = std::chrono::steady_clock::now();
+        for (const auto& worker : workers) {
+            if (worker.pid == 0 || !worker.has_report || now - worker.reported > REPORT_TIMEOUT) {
+                continue;
+            }
+            reporting++;
+            totals.guilds += worker.metrics.guilds;
+            totals.active_games += worker.metrics.active_games;
+            totals.moves_played += worker.metrics.moves_played;
+            totals.games_finished += worker.metrics.games_finished;
+        }
+        std::ostringstream reply;
+        reply << "TOTALS " << reporting << " " << totals.guilds << " " << totals.active_games << " "
+              << totals.moves_played << " " << totals.games_finished << "\n";
+        write_all(fd, reply.str());
+    } else if (command == "OWNER") {
+        uint64_t guild_id = 0;
+        in >> guild_id;
+        uint32_t shard = shard_for_guild(guild_id, config.shards);
+        uint32_t worker = worker_for_guild(guild_id, config);
+        std::ostringstream reply;
+        reply << "OWNER " << worker << " " << shard << " " << (workers[worker].pid != 0 ? 1 : 0) << "\n";
+        write_all(fd, reply.str());
+    } else if (command != "HELLO") {
+        std::cerr << "Unknown IPC message: " << line << std::endl;
+    }
+}
+
+void ShardSupervisor::shutdown_workers() {
+    for (const auto& worker : workers) {
+        if (worker.pid != 0) {
+            kill(worker.pid, SIGTERM);
+        }
+    }
+    for (auto& worker : workers) {
+        if (worker.pid != 0) {
+            waitpid(worker.pid, nullptr, 0);
+            worker.pid = 0;
+        }
+    }
+}
+
+int ShardSupervisor::run() {
+    if (!open_socket()) {
+        return 1;
+    }
+
+    std::signal(SIGINT, handle_stop_signal);
+    std::signal(SIGTERM, handle_stop_signal);
+    std::signal(SIGUSR1, handle_trace_signal);
+
+    std::cout << "Supervisor starting " << config.workers << " workers for " << config.shards
+              << " shards, IPC on " << config.ipc_path << std::endl;
+    last_spawn = std::chrono::steady_clock::now() - config.spawn_interval;
+    reap_and_start();
+
+    // Wake up often enough to honour short spawn intervals
+    int poll_timeout_ms = static_cast<int>(std::max<int64_t>(50, std::min<int64_t>(1000, config.spawn_interval.count())));
+
+    while (!stop_requested.load()) {
+        std::vector<pollfd> fds;
+        fds.push_back({ listen_fd, POLLIN, 0 });
+        for (const auto& connection : connections) {
+            fds.push_back({ connection.fd, POLLIN, 0 });
+        }
+
+        int ready = poll(fds.data(), fds.size(), poll_timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "ERROR: IPC poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        if (ready > 0) {
+            // Connections are handled in reverse so closed ones can be erased in place
+            for (size_t i = fds.size() - 1; i >= 1; i--) {
+                if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                    continue;
+                }
+                Connection& connection = connections[i - 1];
+                char data[4096];
+                ssize_t n = recv(connection.fd, data, sizeof(data), 0);
+                if (n <= 0) {
+                    close(connection.fd);
+                    connections.erase(connections.begin() + (i - 1));
+                    continue;
+                }
+                connection.buffer.append(data, static_cast<size_t>(n));
+                size_t newline;
+                while ((newline = connection.buffer.find('\n')) != std::string::npos) {
+                    std::string line = connection.buffer.substr(0, newline);
+                    connection.buffer.erase(0, newline + 1);
+                    handle_line(connection.fd, line);
+                }
+            }
+
+            if (fds[0].revents & POLLIN) {
+                int fd = accept(listen_fd, nullptr, nullptr);
+                if (fd >= 0) {
+                    connections.push_back({ fd, "" });
+                }
+            }
+        }
+
+        reap_and_start();
+
+        // SIGUSR1 on the supervisor asks every worker for a trace dump
+        if (trace_dump_requested.exchange(false)) {
+            for (const auto& worker : workers) {
+                if (worker.pid != 0) {
+                    kill(worker.pid, SIGUSR1);
+                }
+            }
+        }
+    }
+
+    std::cout << "Supervisor stopping workers..." << std::endl;
+    shutdown_workers();
+    for (const auto& connection : connections) {
+        close(connection.fd);
+    }
+    close(listen_fd);
+    unlink(config.ipc_path.c_str());
+    return 0;
+}
+
+// ShardIpcClient implementation
+ShardIpcClient::ShardIpcClient(const std::string& path, uint32_t worker_id)
+    : path(path), worker_id(worker_id), fd(-1) {
+}
+
+ShardIpcClient::~ShardIpcClient() {
+    disconnect();
+}
+
+void ShardIpcClient::disconnect() {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+    buffer.clear();
+}
+
+bool ShardIpcClient::ensure_connected() {
+    if (fd >= 0) {
+        return true;
+    }
+
+    sockaddr_un addr;
+    if (!fill_address(path, addr)) {
+        return false;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        !write_all(fd, "HELLO " + std::to_string(worker_id) + "\n")) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+bool ShardIpcClient::send_line(const std::string& line) {
+    if (!ensure_connected()) {
+        return false;
+    }
+    if (!write_all(fd, line + "\n")) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+bool ShardIpcClient::read_line(std::string& line, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    size_t newline;
+    while ((newline = buffer.find('\n')) == std::string::npos) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            // A late answer would be mistaken for the next one, so start over
+            disconnect();
+            return false;
+        }
+
+        pollfd pfd = { fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, static_cast<int>(remaining));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        char data[1024];
+        ssize_t n = recv(fd, data, sizeof(data), 0);
+        if (n <= 0) {
+            disconnect();
+            return false;
+        }
+        buffer.append(data, static_cast<size_t>(n));
+    }
+
+    line = buffer.substr(0, newline);
+    buffer.erase(0, newline + 1);
+    return true;
+}
+
+void ShardIpcClient::send_metrics(const WorkerMetrics& metrics) {
+    std::ostringstream line;
+    line << "METRICS " << worker_id << " " << metrics.guilds << " " << metrics.active_games << " "
+         << metrics.moves_played << " " << metrics.games_finished;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    send_line(line.str());
+}
+
+bool ShardIpcClient::query_totals(WorkerMetrics& totals, uint32_t& workers_reporting, int timeout_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::string reply;
+    if (!send_line("TOTALS") || !read_line(reply, timeout_ms)) {
+        return false;
+    }
+
+    std::istringstream in(reply);
+    std::string command;
+    in >> command >> workers_reporting >> totals.guilds >> totals.active_games
+       >> totals.moves_played >> totals.games_finished;
+    return in && command == "TOTALS";
+}
+
+bool ShardIpcClient::query_owner(uint64_t guild_id, uint32_t& worker, uint32_t& shard, bool& alive, int timeout_ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::string reply;
+    if (!send_line("OWNER " + std::to_string(guild_id)) || !read_line(reply, timeout_ms)) {
+        return false;
+    }
+
+    std::istringstream in(reply);
+    std::string command;
+    int alive_flag = 0;
+    in >> command >> worker >> shard >> alive_flag;
+    alive = alive_flag != 0;
+    return in && command == "OWNER";
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <sys/types.h>
+
+// Sharded deployment settings, read from the environment
+struct ShardConfig {
+    uint32_t workers;      // COUNTDRACULA_WORKERS: worker processes, 1 = classic single process
+    uint32_t shards;       // COUNTDRACULA_SHARDS: gateway shards across all workers (default: workers)
+    std::string ipc_path;  // COUNTDRACULA_IPC_PATH: supervisor's Unix socket
+    std::chrono::milliseconds spawn_interval;  // COUNTDRACULA_SPAWN_INTERVAL_MS: gap between worker starts
+
+    static ShardConfig from_env();
+    bool is_sharded() const { return workers > 1; }
+};
+
+// Discord routes a guild's events to shard (guild_id >> 22) % shards, and D++ gives
+// cluster i every shard s with s % maxclusters == i. A guild, and therefore its chess
+// game, always lives in exactly one worker.
+uint32_t shard_for_guild(uint64_t guild_id, uint32_t shards);
+uint32_t worker_for_guild(uint64_t guild_id, const ShardConfig& config);
+
+// Counters a worker reports to the supervisor
+struct WorkerMetrics {
+    uint64_t guilds = 0;
+    uint64_t active_games = 0;
+    uint64_t moves_played = 0;
+    uint64_t games_finished = 0;
+};
+
+// Runs in the parent process: forks one process per worker, restarts workers that
+// die, and answers IPC requests (metrics reports, aggregated totals, guild ownership)
+// on a Unix socket. Workers, including restarts, are started at least spawn_interval
+// apart because Discord only accepts one gateway IDENTIFY per 5 seconds per
+// max_concurrency bucket, and each worker identifies its shards as soon as it starts.
+class ShardSupervisor {
+public:
+    typedef std::function<int(uint32_t worker_id)> worker_main_t;
+
+    ShardSupervisor(const ShardConfig& config, worker_main_t worker_main);
+
+    // Blocks until SIGINT/SIGTERM, then stops the workers. Returns the exit code.
+    int run();
+
+private:
+    struct WorkerState {
+        pid_t pid = 0;
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point reported;
+        bool has_report = false;
+        WorkerMetrics metrics;
+    };
+
+    struct Connection {
+        int fd;
+        std::string buffer;
+    };
+
+    ShardConfig config;
+    worker_main_t worker_main;
+    int listen_fd;
+    std::vector<WorkerState> workers;
+    std::vector<Connection> connections;
+    std::chrono::steady_clock::time_point last_spawn;
+
+    bool open_socket();
+    void spawn(uint32_t worker_id);
+    void reap_and_start();
+    void handle_line(int fd, const std::string& line);
+    void shutdown_workers();
+};
+
+// Worker side of the IPC channel. Calls are serialized; requests wait for the
+// supervisor's answer up to a timeout so a stuck supervisor never blocks a handler for long.
+class ShardIpcClient {
+public:
+    ShardIpcClient(const std::string& path, uint32_t worker_id);
+    ~ShardIpcClient();
+
+    ShardIpcClient(const ShardIpcClient&) = delete;
+    ShardIpcClient& operator=(const ShardIpcClient&) = delete;
+
+    uint32_t get_worker_id() const { return worker_id; }
+
+    void send_metrics(const WorkerMetrics& metrics);
+
+    // Totals across every worker that reported recently
+    bool query_totals(WorkerMetrics& totals, uint32_t& workers_reporting, int timeout_ms = 500);
+
+    // Which worker owns a guild, and whether that worker is currently running
+    bool query_owner(uint64_t guild_id, uint32_t& worker, uint32_t& shard, bool& alive, int timeout_ms = 500);
+
+private:
+    std::string path;
+    uint32_t worker_id;
+    int fd;
+    std::string buffer;
+    std::mutex mutex;
+
+    bool ensure_connected();
+    bool send_line(const std::string& line);
+    bool read_line(std::string& line, int timeout_ms);
+    void disconnect();
+};
@@ -0,0 +1,85 @@
+#include "shard_module.hpp"
+#include "trace.hpp"
+#include <iostream>
+#include <sstream>
+
+ShardModule::ShardModule(dpp::cluster& bot, ShardIpcClient* ipc, metrics_source_t metrics_source)
+    : ipc(ipc), metrics_source(metrics_source) {
+    std::cout << "Initializing Shard Module..." << std::endl;
+
+    bot.on_slashcommand([this](const dpp::slashcommand_t& event) {
+        if (event.command.get_command_name() == "shard_stats") {
+            TRACE_SPAN("ShardModule::dispatch");
+            handle_shard_stats(event);
+        }
+    });
+
+    // Push metrics to the supervisor so any worker can answer for the whole bot
+    if (ipc) {
+        bot.start_timer([this](const dpp::timer&) {
+            this->ipc->send_metrics(this->metrics_source());
+        }, 5);
+    }
+
+    try {
+        dpp::slashcommand stats_cmd("shard_stats", "Show chess activity across all bot workers", bot.me.id);
+
+        const char* guild_id_str = std::getenv("DISCORD_GUILD_ID");
+        if (guild_id_str) {
+            try {
+                dpp::snowflake guild_id = std::stoull(guild_id_str);
+                bot.guild_command_create(stats_cmd, guild_id);
+                std::cout << "Registered command 'shard_stats' for guild ID: " << guild_id << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << "WARNING: Could not parse DISCORD_GUILD_ID for shard module: " << e.what() << std::endl;
+            }
+        }
+
+        // Also register globally (takes up to an hour to propagate)
+        bot.global_command_create(stats_cmd);
+    } catch (const std::exception& e) {
+        std::cerr << "Exception when creating shard_stats command: " << e.what() << std::endl;
+    }
+
+    std::cout << "Shard Module initialized successfully!" << std::endl;
+}
+
+void ShardModule::handle_shard_stats(const dpp::slashcommand_t& event) {
+    WorkerMetrics local = metrics_source();
+    std::stringstream response;
+
+    if (!ipc) {
+        response << "Single process: " << local.guilds << " guilds, " << local.active_games << " active games, "
+                 << local.moves_played << " moves played, " << local.games_finished << " games finished.";
+        event.reply(response.str());
+        return;
+    }
+
+    WorkerMetrics totals;
+    uint32_t reporting = 0;
+    if (ipc->query_totals(totals, reporting)) {
+        response << reporting << " workers reporting: " << totals.guilds << " guilds, " << totals.active_games
+                 << " active games, " << totals.moves_played << " moves played, " << totals.games_finished
+                 << " games finished.";
+    } else {
+        response << "Supervisor unavailable. This worker: " << local.active_games << " active games, "
+                 << local.moves_played << " moves played.";
+    }
+
+    uint32_t worker = 0;
+    uint32_t shard = 0;
+    bool alive = false;
+    if (event.command.guild_id != 0 && ipc->query_owner(event.command.guild_id, worker, shard, alive)) {
+        response << "\nThis server is on shard " << shard << ", owned by worker " << worker;
+        if (!alive) {
+            response << " (restarting)";
+        }
+        if (worker != ipc->get_worker_id()) {
+            // Should not happen: Discord only routes a guild's interactions to its own shard
+            response << " (answered by worker " << ipc->get_worker_id() << ")";
+        }
+        response << ".";
+    }
+
+    event.reply(response.str());
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <dpp/dpp.h>
+#include "modules/shard_ipc.hpp"
+#include <functional>
+
+// Reports this worker's metrics to the shard supervisor and serves /shard_stats.
+// In single-process mode there is no IPC client and only local numbers are shown.
+class ShardModule {
+public:
+    typedef std::function<WorkerMetrics()> metrics_source_t;
+
+    ShardModule(dpp::cluster& bot, ShardIpcClient* ipc, metrics_source_t metrics_source);
+
+private:
+    ShardIpcClient* ipc;
+    metrics_source_t metrics_source;
+
+    void handle_shard_stats(const dpp::slashcommand_t& event);
+};
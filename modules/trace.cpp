@@ -0,0 +1,188 @@
+#include "trace.hpp"
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <unistd.h>
+
+std::atomic<bool> Tracer::enabled(false);
+
+namespace {
+
+const size_t RING_SIZE = 8192;  // spans kept per thread, must be a power of two
+
+// One recorded span. The sequence number works as a seqlock: it is odd while the
+// owning thread is writing the slot and 2 * (index + 1) once the write is complete.
+struct TraceSlot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> start_us{0};
+    std::atomic<int64_t> end_us{0};
+};
+
+// Ring buffer written only by its owning thread
+struct ThreadBuffer {
+    int tid;
+    std::atomic<uint64_t> next{0};
+    TraceSlot slots[RING_SIZE];
+};
+
+std::mutex registry_mutex;
+
+// Buffers are never freed so a dump can still read spans from threads that have exited.
+// Instead, a buffer whose thread exits goes on a free list and is handed to the next new
+// thread, so the registry grows with the peak number of live traced threads rather than
+// with every thread ever created.
+std::vector<ThreadBuffer*>& registry() {
+    static std::vector<ThreadBuffer*>* buffers = new std::vector<ThreadBuffer*>();
+    return *buffers;
+}
+
+std::vector<ThreadBuffer*>& free_buffers() {
+    static std::vector<ThreadBuffer*>* buffers = new std::vector<ThreadBuffer*>();
+    return *buffers;
+}
+
+// Owns the calling thread's buffer and releases it when the thread exits
+struct ThreadBufferHolder {
+    ThreadBuffer* buffer = nullptr;
+
+    ~ThreadBufferHolder() {
+        if (buffer) {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            free_buffers().push_back(buffer);
+        }
+    }
+};
+
+ThreadBuffer* thread_buffer() {
+    thread_local ThreadBufferHolder holder;
+    if (!holder.buffer) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        if (!free_buffers().empty()) {
+            // A reused buffer keeps its tid and sequence numbers; the previous owner has
+            // exited, so its spans and ours never overlap on that track
+            holder.buffer = free_buffers().back();
+            free_buffers().pop_back();
+        } else {
+            holder.buffer = new ThreadBuffer();
+            holder.buffer->tid = static_cast<int>(registry().size()) + 1;
+            registry().push_back(holder.buffer);
+        }
+    }
+    return holder.buffer;
+}
+
+std::atomic<bool> dump_requested(false);
+
+void handle_dump_signal(int) {
+    dump_requested.store(true, std::memory_order_relaxed);
+}
+
+std::string json_escape(const char* text) {
+    std::string escaped;
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            escaped += '\\';
+        }
+        escaped += *c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+void Tracer::set_enabled(bool value) {
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+int64_t Tracer::now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char* name, int64_t start_us, int64_t end_us) {
+    ThreadBuffer* buffer = thread_buffer();
+    uint64_t index = buffer->next.load(std::memory_order_relaxed);
+    TraceSlot& slot = buffer->slots[index & (RING_SIZE - 1)];
+
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start_us.store(start_us, std::memory_order_relaxed);
+    slot.end_us.store(end_us, std::memory_order_relaxed);
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+
+    buffer->next.store(index + 1, std::memory_order_release);
+}
+
+std::string Tracer::to_chrome_json(double seconds) {
+    int64_t cutoff = now_us() - static_cast<int64_t>(seconds * 1e6);
+
+    std::vector<ThreadBuffer*> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        buffers = registry();
+    }
+
+    std::stringstream json;
+    json << "{\"traceEvents\":[";
+    bool first = true;
+    int pid = static_cast<int>(getpid());
+
+    for (ThreadBuffer* buffer : buffers) {
+        uint64_t end = buffer->next.load(std::memory_order_acquire);
+        uint64_t begin = end > RING_SIZE ? end - RING_SIZE : 0;
+
+        for (uint64_t index = begin; index < end; index++) {
+            TraceSlot& slot = buffer->slots[index & (RING_SIZE - 1)];
+
+            uint64_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq != 2 * index + 2) {
+                continue;  // overwritten since we read `end`
+            }
+            const char* name = slot.name.load(std::memory_order_relaxed);
+            int64_t start_us = slot.start_us.load(std::memory_order_relaxed);
+            int64_t end_us = slot.end_us.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != seq || end_us < cutoff) {
+                continue;
+            }
+
+            json << (first ? "" : ",") << "\n{\"name\":\"" << json_escape(name)
+                 << "\",\"ph\":\"X\",\"ts\":" << start_us << ",\"dur\":" << (end_us - start_us)
+                 << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid << "}";
+            first = false;
+        }
+    }
+
+    json << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+    return json.str();
+}
+
+std::string Tracer::dump_to_file(double seconds) {
+    auto now = std::chrono::system_clock::now();
+    auto time_t_now = std::chrono::system_clock::to_time_t(now);
+    std::stringstream path;
+    path << "/tmp/countdracula_trace_" << getpid() << "_" << std::put_time(std::localtime(&time_t_now), "%Y%m%d-%H%M%S") << ".json";
+
+    std::ofstream file(path.str());
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to write trace to " + path.str());
+    }
+    file << to_chrome_json(seconds);
+    return path.str();
+}
+
+void Tracer::install_signal_handler() {
+    std::signal(SIGUSR1, handle_dump_signal);
+}
+
+bool Tracer::poll_dump_request() {
+    return dump_requested.exchange(false, std::memory_order_relaxed);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+// Lightweight scoped tracing for hot paths.
+// Spans are recorded into per-thread ring buffers without locking and can be
+// dumped as Chrome/Perfetto trace-event JSON. When tracing is disabled a span
+// costs a single relaxed atomic load.
+class Tracer {
+public:
+    // Enable or disable recording (also enabled at startup by COUNTDRACULA_TRACE=1)
+    static void set_enabled(bool enabled);
+    static bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Microseconds on the steady clock, as used for span timestamps
+    static int64_t now_us();
+
+    // Record a completed span on the calling thread's buffer. `name` must be a string literal.
+    static void record(const char* name, int64_t start_us, int64_t end_us);
+
+    // Trace-event JSON for the spans that ended in the last `seconds` seconds
+    static std::string to_chrome_json(double seconds);
+
+    // Write to_chrome_json() to a file under /tmp and return its path
+    static std::string dump_to_file(double seconds);
+
+    // SIGUSR1 requests a dump; poll_dump_request() performs it outside the signal handler
+    static void install_signal_handler();
+    static bool poll_dump_request();
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Records the enclosing scope as a span if tracing was enabled when it began
+class TraceSpan {
+private:
+    const char* name;
+    int64_t start_us;
+
+public:
+    explicit TraceSpan(const char* name) : name(name), start_us(Tracer::is_enabled() ? Tracer::now_us() : -1) {}
+    ~TraceSpan() {
+        if (start_us >= 0) {
+            Tracer::record(name, start_us, Tracer::now_us());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#define TRACE_SPAN_CONCAT_INNER(a, b) a##b
+#define TRACE_SPAN_CONCAT(a, b) TRACE_SPAN_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_SPAN_CONCAT(trace_span_, __LINE__)(name)
@@ -0,0 +1,223 @@
+#include "user_cache.hpp"
+#include "trace.hpp"
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+CachedUser to_cached_user(const dpp::user& user) {
+    CachedUser cached;
+    cached.id = user.id;
+    cached.username = user.username;
+    cached.global_name = user.global_name;
+    cached.bot = user.is_bot();
+    return cached;
+}
+
+} // namespace
+
+UserCache::UserCache(dpp::cluster& bot, std::chrono::seconds ttl, size_t max_entries)
+    : bot(bot), ttl(ttl), max_entries(max_entries) {
+}
+
+template <typename Map>
+void UserCache::evict_locked(Map& map) {
+    if (map.size() <= max_entries) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = map.begin(); it != map.end();) {
+        it = (it->second.expires <= now) ? map.erase(it) : std::next(it);
+    }
+    if (map.size() <= max_entries) {
+        return;
+    }
+
+    // Still full of live entries: drop the oldest tenth in one pass so we do not
+    // rescan on every insert
+    std::vector<std::chrono::steady_clock::time_point> expiries;
+    expiries.reserve(map.size());
+    for (const auto& entry : map) {
+        expiries.push_back(entry.second.expires);
+    }
+    size_t drop = std::max<size_t>(1, map.size() / 10);
+    std::nth_element(expiries.begin(), expiries.begin() + (drop - 1), expiries.end());
+    auto threshold = expiries[drop - 1];
+    for (auto it = map.begin(); it != map.end();) {
+        it = (it->second.expires <= threshold) ? map.erase(it) : std::next(it);
+    }
+}
+
+void UserCache::store_user_locked(const CachedUser& user) {
+    users[user.id] = Entry<CachedUser>{ user, std::chrono::steady_clock::now() + ttl };
+    evict_locked(users);
+}
+
+void UserCache::store_user(const dpp::user& user) {
+    if (user.id == 0) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    store_user_locked(to_cached_user(user));
+}
+
+void UserCache::store_member(dpp::snowflake guild_id, const dpp::guild_member& member) {
+    if (member.user_id == 0) {
+        return;
+    }
+
+    // The member payload carries the user object; D++ keeps it in its own cache
+    dpp::user* user = member.get_user();
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (user) {
+        store_user_locked(to_cached_user(*user));
+    }
+    nicknames[std::make_pair(guild_id, member.user_id)] =
+        Entry<std::string>{ member.get_nickname(), std::chrono::steady_clock::now() + ttl };
+    evict_locked(nicknames);
+}
+
+void UserCache::fill_from_interaction(const dpp::interaction& interaction) {
+    TRACE_SPAN("UserCache::fill_from_interaction");
+
+    store_user(interaction.usr);
+    if (interaction.guild_id != 0 && interaction.member.user_id != 0) {
+        store_member(interaction.guild_id, interaction.member);
+    }
+    for (const auto& entry : interaction.resolved.users) {
+        store_user(entry.second);
+    }
+    if (interaction.guild_id != 0) {
+        for (const auto& entry : interaction.resolved.members) {
+            store_member(interaction.guild_id, entry.second);
+        }
+    }
+}
+
+bool UserCache::find(dpp::snowflake user_id, CachedUser& user) {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = users.find(user_id);
+    if (it == users.end() || it->second.expires <= std::chrono::steady_clock::now()) {
+        return false;
+    }
+    user = it->second.value;
+    return true;
+}
+
+void UserCache::get(const std::vector<dpp::snowflake>& user_ids, lookup_callback_t callback) {
+    auto lookup = std::make_shared<PendingLookup>();
+    lookup->callback = std::move(callback);
+    std::vector<dpp::snowflake> to_fetch;
+    bool all_cached;
+
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto now = std::chrono::steady_clock::now();
+
+        for (dpp::snowflake id : user_ids) {
+            if (lookup->results.count(id)) {
+                continue;
+            }
+            auto it = users.find(id);
+            if (it != users.end() && it->second.expires > now) {
+                lookup->results[id] = it->second.value;
+                continue;
+            }
+
+            // Join a fetch already in flight for this user rather than issuing another
+            auto& waiters = in_flight[id];
+            if (std::find(waiters.begin(), waiters.end(), lookup) != waiters.end()) {
+                continue;
+            }
+            if (waiters.empty()) {
+                to_fetch.push_back(id);
+            }
+            waiters.push_back(lookup);
+            lookup->remaining++;
+        }
+        all_cached = lookup->remaining == 0;
+    }
+
+    if (all_cached) {
+        lookup->callback(lookup->results);
+        return;
+    }
+
+    for (dpp::snowflake id : to_fetch) {
+        fetch(id);
+    }
+}
+
+void UserCache::fetch(dpp::snowflake user_id) {
+    bot.user_get(user_id, [this, user_id](const dpp::confirmation_callback_t& callback) {
+        TRACE_SPAN("UserCache::user_get callback");
+        if (callback.is_error()) {
+            std::cerr << "Failed to fetch user " << user_id << ": " << callback.get_error().message << std::endl;
+            complete_fetch(user_id, nullptr);
+            return;
+        }
+        CachedUser user = to_cached_user(callback.get<dpp::user_identified>());
+        complete_fetch(user_id, &user);
+    });
+}
+
+void UserCache::complete_fetch(dpp::snowflake user_id, const CachedUser* user) {
+    std::vector<std::shared_ptr<PendingLookup>> ready;
+
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (user) {
+            store_user_locked(*user);
+        }
+
+        auto it = in_flight.find(user_id);
+        if (it == in_flight.end()) {
+            return;
+        }
+        for (auto& lookup : it->second) {
+            if (user) {
+                lookup->results[user_id] = *user;
+            }
+            if (--lookup->remaining == 0) {
+                ready.push_back(lookup);
+            }
+        }
+        in_flight.erase(it);
+    }
+
+    // Callbacks run outside the lock so they are free to use the cache
+    for (auto& lookup : ready) {
+        lookup->callback(lookup->results);
+    }
+}
+
+std::string UserCache::username_or_fetch(dpp::snowflake user_id) {
+    CachedUser user;
+    if (find(user_id, user)) {
+        return user.username;
+    }
+
+    // Warm the cache for next time; this call does not wait for it
+    get({ user_id }, [](const std::map<dpp::snowflake, CachedUser>&) {});
+    return "user_" + std::to_string(user_id);
+}
+
+std::string UserCache::display_name(dpp::snowflake guild_id, dpp::snowflake user_id) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = nicknames.find(std::make_pair(guild_id, user_id));
+        if (it != nicknames.end() && it->second.expires > std::chrono::steady_clock::now() &&
+            !it->second.value.empty()) {
+            return it->second.value;
+        }
+    }
+
+    CachedUser user;
+    if (find(user_id, user) && !user.global_name.empty()) {
+        return user.global_name;
+    }
+    return username_or_fetch(user_id);
+}
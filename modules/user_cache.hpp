@@ -0,0 +1,79 @@
+#pragma once
+#include <dpp/dpp.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <chrono>
+
+// Cached user info
+struct CachedUser {
+    dpp::snowflake id = 0;
+    std::string username;
+    std::string global_name;
+    bool bot = false;
+};
+
+// Shared cache of user and guild member info with a TTL and a size bound.
+// It is filled for free from interaction payloads (the bot does not request the
+// privileged GUILD_MEMBERS intent, so member gateway events never arrive); misses
+// are fetched over REST, with concurrent misses for the same user sharing one request.
+class UserCache {
+public:
+    typedef std::function<void(const std::map<dpp::snowflake, CachedUser>&)> lookup_callback_t;
+
+    UserCache(dpp::cluster& bot, std::chrono::seconds ttl = std::chrono::minutes(30), size_t max_entries = 10000);
+
+    // Record what an interaction already tells us (issuing user/member and resolved options)
+    void fill_from_interaction(const dpp::interaction& interaction);
+
+    // Fresh cached user, without fetching
+    bool find(dpp::snowflake user_id, CachedUser& user);
+
+    // Look up several users at once. Cached users are returned immediately; misses are
+    // deduplicated against fetches already in flight and fetched asynchronously. The
+    // callback runs once, synchronously if everything was cached; users that could not
+    // be fetched are missing from the result.
+    void get(const std::vector<dpp::snowflake>& user_ids, lookup_callback_t callback);
+
+    // Username for display, falling back to a placeholder (and a background fetch) on a miss
+    std::string username_or_fetch(dpp::snowflake user_id);
+
+    // Guild nickname, then global display name, then username
+    std::string display_name(dpp::snowflake guild_id, dpp::snowflake user_id);
+
+private:
+    template <typename T>
+    struct Entry {
+        T value;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    // A get() call waiting on one or more fetches
+    struct PendingLookup {
+        std::map<dpp::snowflake, CachedUser> results;
+        size_t remaining = 0;
+        lookup_callback_t callback;
+    };
+
+    dpp::cluster& bot;
+    std::chrono::seconds ttl;
+    size_t max_entries;
+
+    std::unordered_map<dpp::snowflake, Entry<CachedUser>> users;
+    std::map<std::pair<dpp::snowflake, dpp::snowflake>, Entry<std::string>> nicknames;  // (guild, user)
+    std::unordered_map<dpp::snowflake, std::vector<std::shared_ptr<PendingLookup>>> in_flight;
+    std::shared_mutex mutex;
+
+    void store_user(const dpp::user& user);
+    void store_member(dpp::snowflake guild_id, const dpp::guild_member& member);
+    void store_user_locked(const CachedUser& user);
+    void fetch(dpp::snowflake user_id);
+    void complete_fetch(dpp::snowflake user_id, const CachedUser* user);
+
+    template <typename Map>
+    void evict_locked(Map& map);
+};